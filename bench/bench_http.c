@@ -0,0 +1,466 @@
+#include "../include/http_server/http.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#define MAX_RESULTS 64
+#define NAME_LEN 64
+#define RUNS 5
+#define NS_WARN_RATIO 1.25
+#define NS_TOLERANCE 2.0     // only gates ns/op when instr/op can't be, see check_baseline
+#define NS_RETRIES 3         // re-measure before calling a slow case a regression
+#define INSTR_TOLERANCE 1.10
+#define ALLOC_TOLERANCE 0.01 // allocation counts are exact
+
+/*
+ * Allocation counting: defining the allocator here interposes it for the
+ * whole process, so allocations libc makes for us (fopen's FILE and stdio
+ * buffer, strdup, ...) are counted too, not just the ones in http.c.
+ */
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void __libc_free(void* ptr);
+
+static uint64_t alloc_count = 0;
+
+void* malloc(size_t size) {
+    alloc_count++;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size) {
+    alloc_count++;
+    return __libc_calloc(n, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    alloc_count++;
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) {
+    __libc_free(ptr);
+}
+
+typedef struct {
+    const char* name;
+    const char* request;
+} CorpusEntry;
+
+static const CorpusEntry corpus[] = {
+    {"curl_get",
+        "GET / HTTP/1.1\r\n"
+        "Host: localhost:9034\r\n"
+        "User-Agent: curl/8.5.0\r\n"
+        "Accept: */*\r\n"
+        "\r\n"},
+    {"browser_get",
+        "GET /index.html HTTP/1.1\r\n"
+        "Host: localhost:9034\r\n"
+        "Connection: keep-alive\r\n"
+        "sec-ch-ua: \"Chromium\";v=\"124\", \"Google Chrome\";v=\"124\", \"Not-A.Brand\";v=\"99\"\r\n"
+        "sec-ch-ua-mobile: ?0\r\n"
+        "sec-ch-ua-platform: \"Linux\"\r\n"
+        "Upgrade-Insecure-Requests: 1\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/124.0.0.0 Safari/537.36\r\n"
+        "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,image/apng,*/*;q=0.8\r\n"
+        "Sec-Fetch-Site: none\r\n"
+        "Sec-Fetch-Mode: navigate\r\n"
+        "Sec-Fetch-User: ?1\r\n"
+        "Sec-Fetch-Dest: document\r\n"
+        "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+        "Accept-Language: en-GB,en-US;q=0.9,en;q=0.8\r\n"
+        "\r\n"},
+    {"browser_css",
+        "GET /style.css HTTP/1.1\r\n"
+        "Host: localhost:9034\r\n"
+        "Connection: keep-alive\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:125.0) Gecko/20100101 Firefox/125.0\r\n"
+        "Accept: text/css,*/*;q=0.1\r\n"
+        "Accept-Language: en-US,en;q=0.5\r\n"
+        "Accept-Encoding: gzip, deflate, br\r\n"
+        "Referer: http://localhost:9034/\r\n"
+        "Sec-Fetch-Dest: style\r\n"
+        "Sec-Fetch-Mode: no-cors\r\n"
+        "Sec-Fetch-Site: same-origin\r\n"
+        "\r\n"},
+    // main.c hands the whole buffer over in one call: only the first request
+    // is served, but "Connection: close" from the last one still matches
+    {"pipelined_3",
+        "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n"
+        "GET /style.css HTTP/1.1\r\nHost: localhost\r\n\r\n"
+        "GET /index.html HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n"},
+    {"close",
+        "GET /index.html HTTP/1.0\r\n"
+        "Host: localhost\r\n"
+        "Connection: close\r\n"
+        "\r\n"},
+    {"not_found",
+        "GET /missing.png HTTP/1.1\r\n"
+        "Host: localhost\r\n"
+        "\r\n"},
+    {"traversal",
+        "GET /../../etc/passwd HTTP/1.1\r\n"
+        "Host: localhost\r\n"
+        "\r\n"},
+    {"bad_method",
+        "POST /index.html HTTP/1.1\r\n"
+        "Host: localhost\r\n"
+        "Content-Length: 0\r\n"
+        "\r\n"},
+    {"bad_version",
+        "GET / HTTP/2.0\r\n"
+        "Host: localhost\r\n"
+        "\r\n"},
+    {"malformed",
+        "GARBAGE\r\n\r\n"},
+    {"long_uri",
+        "GET /aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+        "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+        "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+        "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+        ".html HTTP/1.1\r\n"
+        "Host: localhost\r\n"
+        "\r\n"},
+};
+
+static const size_t corpus_count = sizeof(corpus) / sizeof(CorpusEntry);
+
+typedef void (*BenchFn)(const void* arg);
+
+typedef struct {
+    char name[NAME_LEN];
+    BenchFn fn;
+    const void* arg;
+    int iterations;
+    double ns_per_op;
+    double allocs_per_op;
+    double instr_per_op; // < 0 when perf counters are unavailable
+} BenchResult;
+
+static BenchResult results[MAX_RESULTS];
+static size_t results_count = 0;
+
+static int perf_fd = -1;
+
+static void perf_open(void) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    perf_fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (perf_fd == -1) {
+        fprintf(stderr, "bench_http: perf_event_open unavailable, instr/op not reported\n");
+    }
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// every op touches this so the compiler can't drop the work
+static volatile int sink;
+
+// best of RUNS, and of any earlier call, so noise doesn't look like a regression
+static void measure(BenchResult* r) {
+    for (int run = 0; run < RUNS; run++) {
+        if (perf_fd != -1) {
+            ioctl(perf_fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(perf_fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+        uint64_t allocs_before = alloc_count;
+        uint64_t start = now_ns();
+
+        for (int i = 0; i < r->iterations; i++) r->fn(r->arg);
+
+        uint64_t elapsed = now_ns() - start;
+        uint64_t allocs = alloc_count - allocs_before;
+        uint64_t instructions = 0;
+        if (perf_fd != -1) {
+            ioctl(perf_fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(perf_fd, &instructions, sizeof(instructions)) != sizeof(instructions)) {
+                instructions = 0;
+            }
+        }
+
+        double ns = (double)elapsed / r->iterations;
+        double allocs_per_op = (double)allocs / r->iterations;
+        double instr = (double)instructions / r->iterations;
+
+        if (r->ns_per_op < 0 || ns < r->ns_per_op) r->ns_per_op = ns;
+        if (allocs_per_op > r->allocs_per_op) r->allocs_per_op = allocs_per_op;
+        if (perf_fd != -1 && (r->instr_per_op < 0 || instr < r->instr_per_op)) {
+            r->instr_per_op = instr;
+        }
+    }
+}
+
+static void run_bench(const char* name, BenchFn fn, const void* arg, int iterations) {
+    if (results_count == MAX_RESULTS) return;
+
+    for (int i = 0; i < iterations / 10; i++) fn(arg); // warm caches
+
+    BenchResult* r = &results[results_count++];
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->fn = fn;
+    r->arg = arg;
+    r->iterations = iterations;
+    r->ns_per_op = -1.0;
+    r->allocs_per_op = 0.0;
+    r->instr_per_op = -1.0;
+
+    measure(r);
+
+    printf("%-32s %10.1f ns/op %8.2f allocs/op", r->name, r->ns_per_op, r->allocs_per_op);
+    if (r->instr_per_op >= 0) {
+        printf(" %10.0f instr/op", r->instr_per_op);
+    }
+    printf("\n");
+}
+
+/*
+ * http_parse_request and http_handle_request tokenise in place, so each op
+ * works on a fresh copy like main.c's recv buffer. The copy is part of the
+ * measured cost.
+ */
+static char scratch[MAXLiNE];
+
+static void bench_parse(const void* arg) {
+    const char* request = arg;
+    HttpRequest http_request;
+
+    snprintf(scratch, sizeof(scratch), "%s", request);
+    sink = http_parse_request(scratch, &http_request);
+}
+
+static void bench_mime(const void* arg) {
+    static const char* paths[] = {
+        "/index.html", "/style.css", "/app.js", "/logo.png",
+        "/photo.jpeg", "/data.json", "/README", "/archive.tar.gz",
+    };
+    static HttpResponse http_response;
+
+    for (size_t i = 0; i < sizeof(paths) / sizeof(paths[0]); i++) {
+        sink = http_get_mime_type(paths[i], &http_response);
+    }
+}
+
+static void bench_status(const void* arg) {
+    static HttpResponse http_response;
+
+    for (int r = HTTP_OK; r <= HTTP_URI_TOO_LONG; r++) {
+        http_status_from_result((HttpResult)r, &http_response);
+        sink = http_response.status_code;
+    }
+}
+
+static void bench_serialize(const void* arg) {
+    HttpResponse* http_response = (HttpResponse*)arg;
+
+    sink = http_serialize(http_response);
+    free(http_response->response_buffer);
+    http_response->response_buffer = NULL;
+}
+
+static void bench_handle_request(const void* arg) {
+    const char* request = arg;
+    HttpResponse* http_response = http_init_response();
+    if (http_response == NULL) return;
+
+    snprintf(scratch, sizeof(scratch), "%s", request);
+    sink = http_handle_request(scratch, http_response);
+    sink = http_serialize(http_response);
+
+    http_free_response(http_response);
+}
+
+static int write_baseline(const char* path) {
+    FILE* out = fopen(path, "w");
+    if (out == NULL) {
+        perror("bench_http: baseline");
+        return 1;
+    }
+
+    fprintf(out, "# name ns/op allocs/op instr/op (-1 = not measured)\n");
+    for (size_t i = 0; i < results_count; i++) {
+        fprintf(out, "%s %.1f %.2f %.0f\n",
+            results[i].name,
+            results[i].ns_per_op,
+            results[i].allocs_per_op,
+            results[i].instr_per_op
+        );
+    }
+
+    fclose(out);
+    printf("bench_http: wrote baseline %s\n", path);
+    return 0;
+}
+
+/*
+ * allocs/op always gates. instr/op gates when both this machine and the
+ * baseline have it (-1 = not recorded, only a warning). Otherwise ns/op
+ * is the gate, with a generous ratio since it depends on the machine.
+ */
+static int check_baseline(const char* path) {
+    FILE* in = fopen(path, "r");
+    if (in == NULL) {
+        perror("bench_http: baseline");
+        return 1;
+    }
+
+    char line[256];
+    bool seen[MAX_RESULTS] = {false};
+    int failures = 0;
+
+    while (fgets(line, sizeof(line), in)) {
+        char name[NAME_LEN];
+        double ns, allocs, instr;
+
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%63s %lf %lf %lf", name, &ns, &allocs, &instr) != 4) continue;
+
+        BenchResult* r = NULL;
+        for (size_t i = 0; i < results_count; i++) {
+            if (strcmp(results[i].name, name) == 0) {
+                r = &results[i];
+                seen[i] = true;
+                break;
+            }
+        }
+        if (r == NULL) {
+            fprintf(stderr, "bench_http: %s in baseline but not measured\n", name);
+            continue;
+        }
+
+        if (r->allocs_per_op > allocs + ALLOC_TOLERANCE) {
+            fprintf(stderr, "REGRESSION: %s allocs/op %.2f > baseline %.2f\n",
+                name, r->allocs_per_op, allocs);
+            failures++;
+        }
+        bool instr_gated = r->instr_per_op >= 0 && instr >= 0;
+        if (r->instr_per_op >= 0 && instr < 0) {
+            fprintf(stderr, "WARNING: %s instr/op not recorded in baseline\n", name);
+        }
+        if (instr_gated && r->instr_per_op > instr * INSTR_TOLERANCE) {
+            fprintf(stderr, "REGRESSION: %s instr/op %.0f > baseline %.0f\n",
+                name, r->instr_per_op, instr);
+            failures++;
+        }
+
+        for (int retry = 0; retry < NS_RETRIES && !instr_gated && r->ns_per_op > ns * NS_TOLERANCE; retry++) {
+            measure(r);
+        }
+        if (!instr_gated && r->ns_per_op > ns * NS_TOLERANCE) {
+            fprintf(stderr, "REGRESSION: %s ns/op %.1f > baseline %.1f\n",
+                name, r->ns_per_op, ns);
+            failures++;
+        } else if (r->ns_per_op > ns * NS_WARN_RATIO) {
+            fprintf(stderr, "WARNING: %s ns/op %.1f > baseline %.1f\n",
+                name, r->ns_per_op, ns);
+        }
+    }
+
+    fclose(in);
+
+    for (size_t i = 0; i < results_count; i++) {
+        if (!seen[i]) {
+            fprintf(stderr, "MISSING: %s has no baseline entry\n", results[i].name);
+            failures++;
+        }
+    }
+
+    if (perf_fd == -1) {
+        fprintf(stderr, "bench_http: perf_event_open unavailable, gating on ns/op instead of instr/op\n");
+    }
+
+    if (failures) {
+        fprintf(stderr, "bench_http: %d failure(s) against %s\n", failures, path);
+        return 1;
+    }
+    printf("bench_http: no regressions against %s\n", path);
+    return 0;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr, "usage: %s [--check baseline.txt | --write-baseline baseline.txt]\n", prog);
+}
+
+int main(int argc, char** argv) {
+    const char* check_path = NULL;
+    const char* write_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--check") == 0 && i + 1 < argc) {
+            check_path = argv[++i];
+        } else if (strcmp(argv[i], "--write-baseline") == 0 && i + 1 < argc) {
+            write_path = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    perf_open();
+
+    char name[NAME_LEN];
+
+    for (size_t i = 0; i < corpus_count; i++) {
+        snprintf(name, sizeof(name), "parse/%s", corpus[i].name);
+        run_bench(name, bench_parse, corpus[i].request, 200000);
+    }
+
+    run_bench("mime/8_paths", bench_mime, NULL, 200000);
+    run_bench("status/all_results", bench_status, NULL, 200000);
+
+    // kept for the whole run, check_baseline may measure them again
+    static HttpResponse ok_response;
+    static HttpResponse not_found_response;
+    static char body[1024];
+
+    memset(body, 'x', sizeof(body));
+    ok_response.keep_alive = true;
+    ok_response.content_length = sizeof(body);
+    ok_response.body = body;
+    http_status_from_result(HTTP_OK, &ok_response);
+    http_get_mime_type("/index.html", &ok_response);
+    run_bench("serialize/200_1k_keepalive", bench_serialize, &ok_response, 200000);
+
+    not_found_response.keep_alive = false;
+    http_status_from_result(HTTP_FILE_NOT_FOUND, &not_found_response);
+    http_get_mime_type("/missing.png", &not_found_response);
+    run_bench("serialize/404_close", bench_serialize, &not_found_response, 200000);
+
+    // full path including file IO from ./public
+    for (size_t i = 0; i < corpus_count; i++) {
+        snprintf(name, sizeof(name), "handle/%s", corpus[i].name);
+        run_bench(name, bench_handle_request, corpus[i].request, 20000);
+    }
+
+    int status = 0;
+    if (write_path) {
+        status = write_baseline(write_path);
+    } else if (check_path) {
+        status = check_baseline(check_path);
+    }
+
+    if (perf_fd != -1) {
+        close(perf_fd);
+    }
+    return status;
+}
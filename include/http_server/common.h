@@ -1,6 +1,8 @@
 #ifndef COMMON_H
 #define COMMON_H
 
+#include <netinet/in.h>
+
 #define TIMEOUT 10
 #define MAX_CLIENTS 1024
 #define MAXLiNE 4096
@@ -15,7 +17,7 @@ typedef enum {
 
 typedef struct {
     int fd;
-//    struct sockaddr_in address;
+    struct sockaddr_in address;
 //    time_t last_activity;
     char buf[MAXLiNE];
     int bytes_read;
@@ -35,6 +37,15 @@ static const char* HTTP_503_FULL =
     "\r\n"
     "Server is at capacity";
 
+static const char* HTTP_429_LIMIT =
+    "HTTP/1.1 429 Too Many Requests\r\n"
+    "Content-Type: text/plain\r\n"
+    "Content-Length: 17\r\n"
+    "Retry-After: 1\r\n"
+    "Connection: close\r\n"
+    "\r\n"
+    "Too many requests";
+
 static const char* HTTP_500_ERR = 
     "HTTP/1.1 500 Internal Server Error\r\n"
     "Content-Length: 0\r\n"
@@ -8,6 +8,7 @@
 #include <sys/stat.h>
 
 #include "common.h"
+#include "trace.h"
 
 #define METHOD_LEN 16
 #define PATH_LEN 256
@@ -52,6 +53,10 @@ typedef struct {
 } MimeMap;
 
 HttpResult http_handle_request(char* buf, HttpResponse* http_response);
+HttpResult http_parse_request(char* buf, HttpRequest* http_request);
+HttpResult http_get_mime_type(const char* file_path, HttpResponse* http_response);
+HttpResult http_handle_file_request(char* requested_path, HttpResponse* http_response);
+void http_status_from_result(HttpResult result, HttpResponse* http_response);
 HttpResult http_serialize(HttpResponse* http_response);
 HttpResponse* http_init_response();
 void http_free_response(HttpResponse* http_response);
@@ -15,6 +15,7 @@
 #include <errno.h>
 
 #include "common.h"
+#include "ratelimit.h"
 
 #define MAXQUEUE 128
 #define MAX_EVENTS 100
@@ -25,6 +26,7 @@ typedef struct {
     Client* clients[MAX_CLIENTS];
     struct epoll_event ev;
     struct epoll_event events[MAX_EVENTS];
+    RateLimiter limiter;
 } NetContext;
 
 typedef enum {
@@ -43,7 +45,7 @@ typedef enum {
 NetResult setup_listener_socket(const char* port, NetContext* net_ctx);
 int handle_new_connection(NetContext* net_ctx);
 const char* net_strerror(NetResult status);
-void disconnect_client(Client* c);
+void disconnect_client(NetContext* net_ctx, Client* c);
 void net_init(NetContext* net_ctx);
 void system_cleanup(NetContext* net_ctx);
 
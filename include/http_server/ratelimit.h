@@ -0,0 +1,47 @@
+#ifndef RATELIMIT_H
+#define RATELIMIT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+
+#define RL_TABLE_BITS 11
+#define RL_TABLE_SIZE (1u << RL_TABLE_BITS) // distinct IPs tracked per loop
+#define RL_MAX_PROBE 16                     // give up (and allow) after this
+
+#define RL_REQ_PER_SEC 100
+#define RL_REQ_BURST 200
+#define RL_BYTES_PER_SEC (8 * 1024 * 1024)
+#define RL_BYTES_BURST (16 * 1024 * 1024)
+
+typedef enum {
+    RL_OK = 0,
+    RL_LIMITED,
+    RL_TABLE_FULL, // no slot in probe range, request is let through
+} RateResult;
+
+typedef struct {
+    uint32_t addr;       // IPv4, network order. 0 = never used
+    int32_t req_tokens;  // in thousandths of a request
+    int64_t byte_tokens; // may go negative, the next request pays it off
+    uint64_t last_ms;
+} RateBucket;
+
+// Owned by one event loop, never shared, so no locks or atomics
+typedef struct {
+    RateBucket buckets[RL_TABLE_SIZE];
+} RateLimiter;
+
+static inline uint64_t rl_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+void rl_init(RateLimiter* rl);
+uint32_t rl_hash(uint32_t addr); // home slot of addr
+RateResult rl_acquire(RateLimiter* rl, uint32_t addr, uint64_t now_ms, RateBucket** bucket);
+void rl_charge(RateBucket* bucket, size_t bytes);
+const char* rl_strerror(RateResult result);
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#define TRACE_RING_SIZE 4096   // events kept per loop, oldest overwritten
+#define TRACE_SAMPLE_RATE 64   // trace 1 in N requests
+#define TRACE_OUTPUT "trace.json"
+
+typedef enum {
+    TRACE_EPOLL_WAKE, // epoll_wait returned -> request picked up
+    TRACE_RECV,
+    TRACE_PARSE,
+    TRACE_MIME,
+    TRACE_FILE,
+    TRACE_SERIALIZE,
+    TRACE_SEND,
+    TRACE_STAGE_COUNT
+} TraceStage;
+
+typedef struct {
+    uint64_t start_ns;
+    uint64_t dur_ns;
+    uint32_t request_id;
+    int fd;
+    TraceStage stage;
+} TraceEvent;
+
+typedef struct {
+    TraceEvent events[TRACE_RING_SIZE];
+    size_t head;              // next slot to write
+    size_t count;
+    uint64_t wake_ns;         // last epoll wake
+    uint32_t request_counter; // every request, sampled or not
+    uint32_t current_id;      // 0 when the current request is not sampled
+    int current_fd;
+} TraceRing;
+
+/*
+ * USDT probes: a single nop at each site when nothing is attached, so they
+ * stay compiled in even without HTTP_TRACE. Attach with e.g.
+ *   bpftrace -e 'usdt:./httpserver:httpserver:stage_end { @[arg0] = count(); }'
+ */
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define HTTP_USDT_ENABLED
+#endif
+#endif
+
+#ifdef HTTP_USDT_ENABLED
+#define HTTP_PROBE1(name, a) DTRACE_PROBE1(httpserver, name, a)
+#else
+#define HTTP_PROBE1(name, a) do { (void)(a); } while (0)
+#endif
+
+static inline uint64_t trace_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+#ifdef HTTP_TRACE
+
+void trace_attach(TraceRing* ring);
+void trace_epoll_wake(void);
+void trace_request_begin(int fd, uint64_t start_ns);
+void trace_request_end(void);
+bool trace_sampling(void);
+void trace_record(TraceStage stage, uint64_t start_ns);
+int trace_export_json(const TraceRing* ring, const char* path);
+
+static inline uint64_t trace_stage_begin(TraceStage stage) {
+    HTTP_PROBE1(stage_begin, stage);
+    return trace_sampling() ? trace_now_ns() : 0; // only sampled requests are stamped
+}
+
+// unconditional stamp, for stages that run before the sampling decision
+static inline uint64_t trace_stage_stamp(TraceStage stage) {
+    HTTP_PROBE1(stage_begin, stage);
+    return trace_now_ns();
+}
+
+#define TRACE_STAGE_BEGIN(stage, var) uint64_t var = trace_stage_begin(stage)
+#define TRACE_STAGE_STAMP(stage, var) uint64_t var = trace_stage_stamp(stage)
+#define TRACE_STAGE_END(stage, var) do { \
+        HTTP_PROBE1(stage_end, stage); \
+        if (var) trace_record(stage, var); \
+    } while (0)
+
+#define TRACE_EPOLL_WAKE() trace_epoll_wake()
+#define TRACE_REQUEST_BEGIN(fd, start) trace_request_begin(fd, start)
+#define TRACE_REQUEST_END() trace_request_end()
+
+#else
+
+#define TRACE_STAGE_BEGIN(stage, var) HTTP_PROBE1(stage_begin, stage)
+#define TRACE_STAGE_END(stage, var) HTTP_PROBE1(stage_end, stage)
+#define TRACE_STAGE_STAMP(stage, var) HTTP_PROBE1(stage_begin, stage)
+
+#define TRACE_EPOLL_WAKE() HTTP_PROBE1(epoll_wake, 0)
+#define TRACE_REQUEST_BEGIN(fd, start) HTTP_PROBE1(request_begin, fd)
+#define TRACE_REQUEST_END() HTTP_PROBE1(request_end, 0)
+
+#endif
+
+const char* trace_stage_name(TraceStage stage);
+
+#endif
@@ -209,7 +209,9 @@ HttpResult http_handle_request(char* buf, HttpResponse* http_response) {
     HttpRequest http_request;
     HttpResult http_result;
 
+    TRACE_STAGE_BEGIN(TRACE_PARSE, parse_start);
     http_result = http_parse_request(buf, &http_request);
+    TRACE_STAGE_END(TRACE_PARSE, parse_start);
     if (http_result != HTTP_OK) goto handle_error;
 
     if (strstr(http_request.path, "..")) {
@@ -227,10 +229,14 @@ HttpResult http_handle_request(char* buf, HttpResponse* http_response) {
         http_response->keep_alive = false;
     }
 
+    TRACE_STAGE_BEGIN(TRACE_MIME, mime_start);
     http_result = http_get_mime_type(file_to_serve, http_response);
+    TRACE_STAGE_END(TRACE_MIME, mime_start);
     if (http_result != HTTP_OK) goto handle_error;
 
+    TRACE_STAGE_BEGIN(TRACE_FILE, file_start);
     http_result = http_handle_file_request(file_to_serve, http_response);
+    TRACE_STAGE_END(TRACE_FILE, file_start);
     if (http_result != HTTP_OK) goto handle_error;
 
     http_status_from_result(http_result, http_response);
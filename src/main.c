@@ -1,6 +1,7 @@
 #include "../include/http_server/network.h"
 #include "../include/http_server/http.h"
 #include "../include/http_server/common.h"
+#include "../include/http_server/trace.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -20,7 +21,7 @@
 
 #define PORT "9034"
 
-volatile int keep_running = 1;
+volatile sig_atomic_t keep_running = 1;
 
 void handle_sigint(int sig) {
     keep_running = 0;
@@ -31,6 +32,7 @@ int main() {
 
     NetResult net_result;
     HttpResult http_result;
+    RateResult rl_result;
 
     int num_bytes;
     int num_fds;
@@ -39,6 +41,11 @@ int main() {
     NetContext net_ctx;
     net_init(&net_ctx);
 
+#ifdef HTTP_TRACE
+    static TraceRing trace_ring;
+    trace_attach(&trace_ring);
+#endif
+
     net_ctx.epoll_fd = epoll_create1(0);
     if (net_ctx.epoll_fd == -1) {
         perror("epoll_create1");
@@ -52,12 +59,14 @@ int main() {
     }
 
 
-    while (1) {
+    while (keep_running) {
         num_fds = epoll_wait(net_ctx.epoll_fd, net_ctx.events, MAX_EVENTS, -1);
         if (num_fds == -1) {
+            if (errno == EINTR) continue; // SIGINT, loop condition ends it
             perror("epoll_wait");
             exit(EXIT_FAILURE);
         }
+        TRACE_EPOLL_WAKE();
 
         for (int i = 0; i < num_fds; i++) {
             if (net_ctx.events[i].data.fd == net_ctx.listener) {              
@@ -71,6 +80,7 @@ int main() {
             Client* c = (Client*)net_ctx.events[i].data.ptr;
             int current_fd = c->fd;
 
+            TRACE_STAGE_STAMP(TRACE_RECV, recv_start);
             num_bytes = recv(current_fd, c->buf, sizeof(c->buf) - 1, 0);
 
             switch(num_bytes) {
@@ -80,12 +90,28 @@ int main() {
                     } else {
                         perror("recv error");
                     }
-                    disconnect_client(c);
+                    TRACE_STAGE_END(TRACE_RECV, recv_start);
+                    disconnect_client(&net_ctx, c);
                     break;
                 case 0: // Connection closed
-                    disconnect_client(c);
+                    TRACE_STAGE_END(TRACE_RECV, recv_start);
+                    disconnect_client(&net_ctx, c);
                     break;
                 default: {// Got data!
+                    TRACE_REQUEST_BEGIN(current_fd, recv_start);
+                    TRACE_STAGE_END(TRACE_RECV, recv_start);
+
+                    RateBucket* bucket;
+                    rl_result = rl_acquire(&net_ctx.limiter, c->address.sin_addr.s_addr, rl_now_ms(), &bucket);
+                    if (rl_result == RL_LIMITED) {
+                        send(current_fd, HTTP_429_LIMIT, strlen(HTTP_429_LIMIT), 0);
+                        disconnect_client(&net_ctx, c);
+                        break;
+                    }
+                    if (rl_result != RL_OK) {
+                        fprintf(stderr, "ERROR: %s\n", rl_strerror(rl_result));
+                    }
+
                     HttpResponse* http_response = http_init_response();
                     c->buf[num_bytes] = '\0';
 
@@ -94,24 +120,43 @@ int main() {
                         fprintf(stderr, "ERROR: %s\n", http_strerror(http_result));
                     }
 
-                    if (http_serialize(http_response) != HTTP_OK) {
+                    TRACE_STAGE_BEGIN(TRACE_SERIALIZE, serialize_start);
+                    http_result = http_serialize(http_response);
+                    TRACE_STAGE_END(TRACE_SERIALIZE, serialize_start);
+
+                    TRACE_STAGE_BEGIN(TRACE_SEND, send_start);
+                    if (http_result != HTTP_OK) {
                         send(current_fd, HTTP_500_ERR, strlen(HTTP_500_ERR), 0);
                         http_response->keep_alive = false;
                     } else {
-                        if (send(current_fd, http_response->response_buffer, http_response->response_size, 0) == -1) {
+                        ssize_t sent = send(current_fd, http_response->response_buffer, http_response->response_size, 0);
+                        if (sent == -1) {
                             perror("send");
+                        } else {
+                            rl_charge(bucket, (size_t)sent);
                         }
                     }
+                    TRACE_STAGE_END(TRACE_SEND, send_start);
 
                     if (!http_response->keep_alive) {
-                        disconnect_client(c);
+                        disconnect_client(&net_ctx, c);
                     }
                     http_free_response(http_response);
                     break;
                 }
             }
+            TRACE_REQUEST_END();
         }
     }
+
+#ifdef HTTP_TRACE
+    if (trace_export_json(&trace_ring, TRACE_OUTPUT) == -1) {
+        perror("trace_export_json");
+    } else {
+        printf("httpserver: wrote %s\n", TRACE_OUTPUT);
+    }
+#endif
+
     system_cleanup(&net_ctx);
     return 0;
 }
\ No newline at end of file
@@ -7,6 +7,8 @@ void net_init(NetContext* net_ctx) {
     for (int i = 0; i < MAX_CLIENTS; i++) {
         net_ctx->clients[i] = NULL;
     }
+
+    rl_init(&net_ctx->limiter);
 }
 
 NetResult setup_listener_socket(const char* port, NetContext* net_ctx) {
@@ -91,6 +93,7 @@ int handle_new_connection(NetContext* net_ctx) {
     }
     
     c->fd = conn_sock;
+    c->address = remote_addr;
     c->bytes_read = 0;
     c->bytes_sent = 0;
     c->bytes_to_send = 0;
@@ -109,7 +112,7 @@ int handle_new_connection(NetContext* net_ctx) {
     #endif
 }
 
-void disconnect_client(Client* c) {
+void disconnect_client(NetContext* net_ctx, Client* c) {
     if (!c) return;
 
     #ifdef DEBUG
@@ -117,6 +120,9 @@ void disconnect_client(Client* c) {
     #endif
 
     close(c->fd);
+    if (c->fd >= 0 && c->fd < MAX_CLIENTS) {
+        net_ctx->clients[c->fd] = NULL;
+    }
 
     if (c->protocol_res) {
         free(c->protocol_res);
@@ -127,11 +133,7 @@ void disconnect_client(Client* c) {
 
 void system_cleanup(NetContext* net_ctx) {
     for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (net_ctx->clients[i] != NULL) {
-            close(net_ctx->clients[i]->fd);
-            free(net_ctx->clients[i]);
-            net_ctx->clients[i] = NULL;
-        }
+        disconnect_client(net_ctx, net_ctx->clients[i]);
     }
 }
 
@@ -0,0 +1,104 @@
+#include "../include/http_server/ratelimit.h"
+
+#include <string.h>
+#include <stdbool.h>
+
+void rl_init(RateLimiter* rl) {
+    memset(rl->buckets, 0, sizeof(rl->buckets));
+}
+
+uint32_t rl_hash(uint32_t addr) {
+    return (addr * 2654435761u) >> (32 - RL_TABLE_BITS);
+}
+
+static void rl_reset(RateBucket* b, uint32_t addr, uint64_t now_ms) {
+    b->addr = addr;
+    b->req_tokens = RL_REQ_BURST * 1000;
+    b->byte_tokens = RL_BYTES_BURST;
+    b->last_ms = now_ms;
+}
+
+// tokens are clamped to the burst after crediting, so any byte debt is
+// paid off at the real rate however long the client was away
+static void rl_refill(RateBucket* b, uint64_t now_ms) {
+    if (now_ms <= b->last_ms) return;
+    int64_t elapsed = (int64_t)(now_ms - b->last_ms);
+
+    int64_t req = b->req_tokens + elapsed * RL_REQ_PER_SEC;
+    b->req_tokens = req > RL_REQ_BURST * 1000 ? RL_REQ_BURST * 1000 : (int32_t)req;
+
+    int64_t bytes = b->byte_tokens + elapsed * RL_BYTES_PER_SEC / 1000;
+    b->byte_tokens = bytes > RL_BYTES_BURST ? RL_BYTES_BURST : bytes;
+
+    b->last_ms = now_ms;
+}
+
+// Both buckets would be full by now, so handing the slot to another
+// address can't change anyone's limits.
+static bool rl_stale(const RateBucket* b, uint64_t now_ms) {
+    if (now_ms <= b->last_ms) return false;
+    int64_t elapsed = (int64_t)(now_ms - b->last_ms);
+
+    return b->req_tokens + elapsed * RL_REQ_PER_SEC >= RL_REQ_BURST * 1000 &&
+        b->byte_tokens + elapsed * RL_BYTES_PER_SEC / 1000 >= RL_BYTES_BURST;
+}
+
+RateResult rl_acquire(RateLimiter* rl, uint32_t addr, uint64_t now_ms, RateBucket** bucket) {
+    uint32_t slot = rl_hash(addr);
+    RateBucket* stale = NULL;
+    RateBucket* b = NULL;
+
+    /*
+     * Linear probe. Slots are never emptied, only taken over once stale,
+     * so a never-used slot still means the address isn't further along.
+     */
+    for (int i = 0; i < RL_MAX_PROBE; i++) {
+        RateBucket* cur = &rl->buckets[(slot + i) & (RL_TABLE_SIZE - 1)];
+
+        if (cur->addr == addr) {
+            b = cur;
+            break;
+        }
+        if (cur->addr == 0) {
+            if (!stale) stale = cur;
+            break;
+        }
+        if (!stale && rl_stale(cur, now_ms)) {
+            stale = cur;
+        }
+    }
+
+    if (b == NULL) {
+        if (stale == NULL) {
+            *bucket = NULL;
+            return RL_TABLE_FULL;
+        }
+        b = stale;
+        rl_reset(b, addr, now_ms);
+    } else {
+        rl_refill(b, now_ms);
+    }
+
+    *bucket = b;
+
+    if (b->req_tokens < 1000 || b->byte_tokens <= 0) {
+        return RL_LIMITED;
+    }
+
+    b->req_tokens -= 1000;
+    return RL_OK;
+}
+
+void rl_charge(RateBucket* bucket, size_t bytes) {
+    if (bucket == NULL) return;
+    bucket->byte_tokens -= (int64_t)bytes;
+}
+
+const char* rl_strerror(RateResult result) {
+    switch (result) {
+        case RL_OK:         return "Success";
+        case RL_LIMITED:    return "Client over rate limit";
+        case RL_TABLE_FULL: return "Rate limit table full";
+        default:            return "Unknown rate limit error";
+    }
+}
@@ -0,0 +1,116 @@
+#include "../include/http_server/trace.h"
+
+const char* trace_stage_name(TraceStage stage) {
+    switch (stage) {
+        case TRACE_EPOLL_WAKE: return "epoll_wake";
+        case TRACE_RECV:       return "recv";
+        case TRACE_PARSE:      return "http_parse_request";
+        case TRACE_MIME:       return "http_get_mime_type";
+        case TRACE_FILE:       return "http_handle_file_request";
+        case TRACE_SERIALIZE:  return "http_serialize";
+        case TRACE_SEND:       return "send";
+        default:               return "unknown";
+    }
+}
+
+#ifdef HTTP_TRACE
+
+// one event loop -> one ring, so no locking
+static TraceRing* active_ring = NULL;
+
+void trace_attach(TraceRing* ring) {
+    ring->head = 0;
+    ring->count = 0;
+    ring->wake_ns = 0;
+    ring->request_counter = 0;
+    ring->current_id = 0;
+    ring->current_fd = -1;
+    active_ring = ring;
+}
+
+void trace_epoll_wake(void) {
+    HTTP_PROBE1(epoll_wake, 0);
+    if (active_ring) {
+        active_ring->wake_ns = trace_now_ns();
+    }
+}
+
+bool trace_sampling(void) {
+    return active_ring != NULL && active_ring->current_id != 0;
+}
+
+static void trace_push(TraceStage stage, uint64_t start_ns, uint64_t end_ns) {
+    TraceEvent* ev = &active_ring->events[active_ring->head];
+    ev->start_ns = start_ns;
+    ev->dur_ns = end_ns - start_ns;
+    ev->request_id = active_ring->current_id;
+    ev->fd = active_ring->current_fd;
+    ev->stage = stage;
+
+    active_ring->head = (active_ring->head + 1) % TRACE_RING_SIZE;
+    if (active_ring->count < TRACE_RING_SIZE) {
+        active_ring->count++;
+    }
+}
+
+void trace_request_begin(int fd, uint64_t start_ns) {
+    HTTP_PROBE1(request_begin, fd);
+    if (!active_ring) return;
+
+    uint32_t n = ++active_ring->request_counter;
+    if (n % TRACE_SAMPLE_RATE != 0) {
+        active_ring->current_id = 0;
+        return;
+    }
+
+    active_ring->current_id = n;
+    active_ring->current_fd = fd;
+
+    // time spent between the wake and this client being served
+    if (active_ring->wake_ns && active_ring->wake_ns <= start_ns) {
+        trace_push(TRACE_EPOLL_WAKE, active_ring->wake_ns, start_ns);
+    }
+}
+
+void trace_request_end(void) {
+    HTTP_PROBE1(request_end, 0);
+    if (active_ring) {
+        active_ring->current_id = 0;
+    }
+}
+
+void trace_record(TraceStage stage, uint64_t start_ns) {
+    if (!trace_sampling()) return;
+    trace_push(stage, start_ns, trace_now_ns());
+}
+
+// Chrome trace event format, loads in chrome://tracing and ui.perfetto.dev
+int trace_export_json(const TraceRing* ring, const char* path) {
+    FILE* out = fopen(path, "w");
+    if (out == NULL) {
+        return -1;
+    }
+
+    size_t start = (ring->head + TRACE_RING_SIZE - ring->count) % TRACE_RING_SIZE;
+
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    for (size_t i = 0; i < ring->count; i++) {
+        const TraceEvent* ev = &ring->events[(start + i) % TRACE_RING_SIZE];
+        fprintf(out,
+            "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+            "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"fd\":%d}}",
+            i ? ",\n" : "",
+            trace_stage_name(ev->stage),
+            ev->request_id,
+            ev->start_ns / 1000.0,
+            ev->dur_ns / 1000.0,
+            ev->fd
+        );
+    }
+    fprintf(out, "\n]}\n");
+
+    fclose(out);
+    return 0;
+}
+
+#endif
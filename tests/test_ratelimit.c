@@ -0,0 +1,135 @@
+#include "../include/http_server/ratelimit.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+#define T0 1000000 // arbitrary start, the limiter only looks at differences
+
+static RateLimiter rl;
+
+static RateResult acquire(uint32_t addr, uint64_t now_ms) {
+    RateBucket* bucket;
+    return rl_acquire(&rl, addr, now_ms, &bucket);
+}
+
+// another address whose probe sequence starts at the same slot
+static uint32_t colliding_addr(uint32_t addr) {
+    for (uint32_t other = addr + 1; ; other++) {
+        if (rl_hash(other) == rl_hash(addr)) return other;
+    }
+}
+
+static void test_burst_then_refill(void) {
+    uint32_t addr = 0x0100007f;
+    rl_init(&rl);
+
+    for (int i = 0; i < RL_REQ_BURST; i++) {
+        CHECK(acquire(addr, T0) == RL_OK);
+    }
+    CHECK(acquire(addr, T0) == RL_LIMITED);
+
+    // one request's worth of refill
+    uint64_t one = 1000 / RL_REQ_PER_SEC;
+    CHECK(acquire(addr, T0 + one) == RL_OK);
+    CHECK(acquire(addr, T0 + one) == RL_LIMITED);
+
+    // a long gap refills to the burst and no further
+    uint64_t later = T0 + 3600 * 1000;
+    for (int i = 0; i < RL_REQ_BURST; i++) {
+        CHECK(acquire(addr, later) == RL_OK);
+    }
+    CHECK(acquire(addr, later) == RL_LIMITED);
+}
+
+static void test_byte_debt(void) {
+    uint32_t addr = 0x0200007f;
+    int64_t debt = 10 * (int64_t)RL_BYTES_PER_SEC; // 10s worth past the burst
+    RateBucket* bucket;
+    rl_init(&rl);
+
+    CHECK(rl_acquire(&rl, addr, T0, &bucket) == RL_OK);
+    rl_charge(bucket, RL_BYTES_BURST + debt);
+    CHECK(acquire(addr, T0) == RL_LIMITED);
+
+    // debt is repaid at the real rate, even across one long gap
+    CHECK(acquire(addr, T0 + 9000) == RL_LIMITED);
+    CHECK(acquire(addr, T0 + 10001) == RL_OK);
+
+    // and a huge debt is not forgiven after a fixed idle time
+    rl_init(&rl);
+    CHECK(rl_acquire(&rl, addr, T0, &bucket) == RL_OK);
+    rl_charge(bucket, RL_BYTES_BURST + 100 * (int64_t)RL_BYTES_PER_SEC);
+    CHECK(acquire(addr, T0 + 60 * 1000) == RL_LIMITED);
+    CHECK(acquire(addr, T0 + 100 * 1000 + 1) == RL_OK);
+}
+
+static void test_stale_takeover(void) {
+    uint32_t a = 0x0300007f;
+    uint32_t b = colliding_addr(a);
+    RateBucket* bucket;
+    rl_init(&rl);
+
+    // a's slot is in debt, so b must not take it over
+    CHECK(rl_acquire(&rl, a, T0, &bucket) == RL_OK);
+    RateBucket* a_slot = bucket;
+    rl_charge(bucket, RL_BYTES_BURST + 30 * (int64_t)RL_BYTES_PER_SEC);
+
+    CHECK(rl_acquire(&rl, b, T0 + 15000, &bucket) == RL_OK);
+    CHECK(bucket != a_slot);
+    CHECK(acquire(a, T0 + 15000) == RL_LIMITED);
+
+    // once a would have refilled completely its slot is fair game
+    rl_init(&rl);
+    CHECK(rl_acquire(&rl, a, T0, &bucket) == RL_OK);
+    a_slot = bucket;
+    CHECK(rl_acquire(&rl, b, T0 + 10 * 1000, &bucket) == RL_OK);
+    CHECK(bucket == a_slot);
+    CHECK(bucket->addr == b);
+}
+
+static void test_table_full(void) {
+    uint32_t addr = 0x0400007f;
+    uint32_t window[RL_MAX_PROBE];
+    rl_init(&rl);
+
+    // occupy the whole probe range of addr with live buckets
+    window[0] = addr;
+    for (int i = 1; i < RL_MAX_PROBE; i++) {
+        window[i] = colliding_addr(window[i - 1]);
+    }
+    for (int i = 0; i < RL_MAX_PROBE; i++) {
+        CHECK(acquire(window[i], T0) == RL_OK);
+    }
+
+    uint32_t extra = colliding_addr(window[RL_MAX_PROBE - 1]);
+    RateBucket* bucket;
+    CHECK(rl_acquire(&rl, extra, T0, &bucket) == RL_TABLE_FULL);
+    CHECK(bucket == NULL);
+
+    // existing entries are still found
+    CHECK(acquire(window[RL_MAX_PROBE - 1], T0) == RL_OK);
+}
+
+int main(void) {
+    test_burst_then_refill();
+    test_byte_debt();
+    test_stale_takeover();
+    test_table_full();
+
+    if (failures) {
+        fprintf(stderr, "test_ratelimit: %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("test_ratelimit: all checks passed\n");
+    return 0;
+}